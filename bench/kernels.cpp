@@ -0,0 +1,535 @@
+/**
+ * @file kernels.cpp
+ * @brief Microbenchmarks for the hot simulation and rendering kernels.
+ *
+ * Each kernel is timed in isolation over fixed synthetic particle
+ * distributions (uniform, clustered, packed). Every repetition starts from a
+ * fresh copy of the same scene, so kernels that move particles do not drift
+ * between runs. Results are printed as min/median/p99/max and can be written
+ * to JSON and compared against a stored baseline. p99 is only reported with at
+ * least 100 repetitions, below that it would just be the maximum.
+ *
+ * Usage:
+ *   bench [--sizes 1000,10000,100000] [--reps N] [--warmup 2] [--render]
+ *         [--out results.json] [--baseline baseline.json] [--threshold 10]
+ *
+ * Without --reps, sizes up to 10k run 100 repetitions and larger sizes 20.
+ * Renderer::render is only timed with --render, since creating a render
+ * texture needs a display.
+ *
+ * The exit code is 1 if any kernel's median regressed by more than
+ * --threshold percent against the baseline, or if a kernel in the baseline
+ * was not measured.
+ */
+
+#include "SFML/Graphics/RenderTexture.hpp"
+#include "particle.hpp"
+#include "render.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr float particle_radius = 3.0f;
+
+enum class Distribution { Uniform, Clustered, Packed };
+
+const char *distributionName(Distribution distribution) {
+    switch (distribution) {
+    case Distribution::Uniform:
+        return "uniform";
+    case Distribution::Clustered:
+        return "clustered";
+    case Distribution::Packed:
+        return "packed";
+    }
+    return "unknown";
+}
+
+// Fewest samples for which a p99 is distinguishable from the maximum
+constexpr std::size_t min_p99_samples = 100;
+
+struct Stats {
+    double min_ns = 0.0;
+    double median_ns = 0.0;
+    double p99_ns = 0.0; // Zero if there were too few samples
+    double max_ns = 0.0;
+};
+
+struct Result {
+    std::string kernel;
+    std::string distribution;
+    std::size_t size = 0;
+    Stats stats;
+};
+
+struct Options {
+    std::vector<std::size_t> sizes = {1000, 10000, 100000};
+    int reps = 0; // 0 picks a count from the scene size
+    int warmup = 2;
+    bool render = false;
+    double threshold = 10.0; // percent
+    std::string out;
+    std::string baseline;
+};
+
+float clampToWorld(float v) {
+    return std::min(std::max(v, particle_radius), world_size - particle_radius);
+}
+
+std::vector<sf::Vector2f> makePositions(Distribution distribution,
+                                        std::size_t n) {
+    std::mt19937 rng(1234); // Fixed seed, scenes must be reproducible
+    std::vector<sf::Vector2f> positions;
+    positions.reserve(n);
+
+    switch (distribution) {
+    case Distribution::Uniform: {
+        std::uniform_real_distribution<float> coord(
+            particle_radius, world_size - particle_radius);
+        for (std::size_t i = 0; i < n; ++i)
+            positions.emplace_back(coord(rng), coord(rng));
+        break;
+    }
+    case Distribution::Clustered: {
+        const int num_clusters = 8;
+        std::uniform_real_distribution<float> center(100.0f,
+                                                     world_size - 100.0f);
+        std::normal_distribution<float> offset(0.0f, 30.0f);
+        std::vector<sf::Vector2f> centers;
+        for (int i = 0; i < num_clusters; ++i)
+            centers.emplace_back(center(rng), center(rng));
+        for (std::size_t i = 0; i < n; ++i) {
+            const sf::Vector2f &c = centers[i % num_clusters];
+            positions.emplace_back(clampToWorld(c.x + offset(rng)),
+                                   clampToWorld(c.y + offset(rng)));
+        }
+        break;
+    }
+    case Distribution::Packed: {
+        // Square lattice with slightly overlapping neighbours, compressed
+        // further if the lattice would not fit inside the world.
+        const std::size_t side =
+            static_cast<std::size_t>(std::ceil(std::sqrt(n)));
+        const float spacing =
+            std::min(1.8f * particle_radius,
+                     (world_size - 2.0f * particle_radius) / side);
+        for (std::size_t i = 0; i < n; ++i) {
+            float x = particle_radius + spacing * (i % side);
+            float y = particle_radius + spacing * (i / side);
+            positions.emplace_back(x, y);
+        }
+        break;
+    }
+    }
+    return positions;
+}
+
+Stats summarize(std::vector<double> samples) {
+    Stats stats;
+    if (samples.empty())
+        return stats;
+    std::sort(samples.begin(), samples.end());
+    const std::size_t n = samples.size();
+    stats.min_ns = samples.front();
+    stats.median_ns = n % 2 ? samples[n / 2]
+                            : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    stats.max_ns = samples.back();
+    if (n >= min_p99_samples) {
+        std::size_t p99 = static_cast<std::size_t>(std::ceil(0.99 * n));
+        stats.p99_ns = samples[p99 - 1];
+    }
+    return stats;
+}
+
+int repsFor(const Options &options, std::size_t size) {
+    if (options.reps > 0)
+        return options.reps;
+    return size <= 10000 ? static_cast<int>(min_p99_samples) : 20;
+}
+
+} // namespace
+
+/**
+ * @class KernelBench
+ * @brief Friend of ParticleManager, exposes its private kernels for timing.
+ */
+class KernelBench {
+  public:
+    static void populate(ParticleManager &manager,
+                         const std::vector<sf::Vector2f> &positions) {
+        for (const auto &pos : positions)
+            manager.addObject(pos, particle_radius);
+        // A zero-length step leaves positions untouched and rebuilds the
+        // collision grid the same way update() does.
+        manager.updateObjects(0.0f);
+    }
+
+    /**
+     * @brief Reset work to the particles and grid of scene.
+     *
+     * ParticleManager owns a command queue and is not copyable, so only the
+     * state the kernels touch is copied.
+     */
+    static void copyScene(ParticleManager &work, const ParticleManager &scene) {
+        work.objects = scene.objects;
+        for (int i = 0; i < ParticleManager::grid_cells; ++i)
+            for (int j = 0; j < ParticleManager::grid_cells; ++j)
+                work.grid[i][j] = scene.grid[i][j];
+    }
+
+    static void particleUpdate(ParticleManager &manager) noexcept {
+        const float dt = manager.getStepDt();
+        for (auto &obj : manager.objects)
+            obj.update(dt);
+    }
+
+    static void checkCollisions(ParticleManager &manager) noexcept {
+        manager.checkCollisions();
+    }
+
+    static std::size_t getCollisionParticles(const ParticleManager &manager) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < manager.objects.size(); ++i)
+            total +=
+                manager.getCollisionParticles(static_cast<int>(i)).size();
+        return total;
+    }
+
+    static void applyBoundary(ParticleManager &manager) noexcept {
+        manager.applyBoundary();
+    }
+};
+
+namespace {
+
+volatile std::size_t sink = 0; // Keeps results of pure kernels alive
+
+using Kernel = std::function<void(ParticleManager &)>;
+
+/**
+ * @brief Time a kernel over warmup + reps runs, each on a fresh copy of the
+ * scene. Only the kernel call itself is inside the timed region, setup (if
+ * given) runs before each call outside of it.
+ */
+Stats measure(const ParticleManager &scene, int warmup, int reps,
+              const Kernel &kernel, const Kernel &setup = {}) {
+    std::vector<double> samples;
+    samples.reserve(reps);
+    auto work = std::make_unique<ParticleManager>();
+    for (int i = 0; i < warmup + reps; ++i) {
+        KernelBench::copyScene(*work, scene);
+        if (setup)
+            setup(*work);
+        auto start = std::chrono::steady_clock::now();
+        kernel(*work);
+        auto end = std::chrono::steady_clock::now();
+        if (i >= warmup)
+            samples.push_back(
+                std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return summarize(std::move(samples));
+}
+
+std::string jsonString(const std::string &line, const std::string &key) {
+    std::size_t pos = line.find("\"" + key + "\"");
+    if (pos == std::string::npos)
+        return {};
+    std::size_t begin = line.find('"', line.find(':', pos) + 1);
+    std::size_t end = line.find('"', begin + 1);
+    if (begin == std::string::npos || end == std::string::npos)
+        return {};
+    return line.substr(begin + 1, end - begin - 1);
+}
+
+double jsonNumber(const std::string &line, const std::string &key) {
+    std::size_t pos = line.find("\"" + key + "\"");
+    if (pos == std::string::npos)
+        return 0.0;
+    return std::strtod(line.c_str() + line.find(':', pos) + 1, nullptr);
+}
+
+bool writeJson(const std::string &path, const std::vector<Result> &results) {
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    // One result per line, readBaseline() relies on this layout.
+    file << "{\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        file << "    {\"kernel\": \"" << r.kernel << "\", \"distribution\": \""
+             << r.distribution << "\", \"size\": " << r.size
+             << ", \"min_ns\": " << r.stats.min_ns
+             << ", \"median_ns\": " << r.stats.median_ns
+             << ", \"p99_ns\": " << r.stats.p99_ns
+             << ", \"max_ns\": " << r.stats.max_ns << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+std::vector<Result> readBaseline(const std::string &path) {
+    std::vector<Result> results;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find("\"kernel\"") == std::string::npos)
+            continue;
+        Result r;
+        r.kernel = jsonString(line, "kernel");
+        r.distribution = jsonString(line, "distribution");
+        r.size = static_cast<std::size_t>(jsonNumber(line, "size"));
+        r.stats.min_ns = jsonNumber(line, "min_ns");
+        r.stats.median_ns = jsonNumber(line, "median_ns");
+        r.stats.p99_ns = jsonNumber(line, "p99_ns");
+        r.stats.max_ns = jsonNumber(line, "max_ns");
+        results.push_back(r);
+    }
+    return results;
+}
+
+bool sameCase(const Result &a, const Result &b) {
+    return a.kernel == b.kernel && a.distribution == b.distribution &&
+           a.size == b.size;
+}
+
+/**
+ * @brief Compare medians against the baseline.
+ * @return Number of kernels that regressed by more than the threshold plus
+ * the number of baseline kernels that were not measured in this run.
+ */
+int compare(const std::vector<Result> &results,
+            const std::vector<Result> &baseline, double threshold) {
+    int failures = 0;
+    std::printf("\n%-22s %-10s %9s %14s %14s %9s\n", "kernel", "dist", "size",
+                "base med(us)", "cur med(us)", "change");
+    for (const Result &r : results) {
+        auto it = std::find_if(
+            baseline.begin(), baseline.end(),
+            [&r](const Result &b) { return sameCase(b, r); });
+        if (it == baseline.end() || it->stats.median_ns <= 0.0) {
+            std::printf("%-22s %-10s %9zu %14s %14.1f %9s  NO BASELINE\n",
+                        r.kernel.c_str(), r.distribution.c_str(), r.size, "-",
+                        r.stats.median_ns / 1000.0, "-");
+            continue;
+        }
+        double change =
+            100.0 * (r.stats.median_ns - it->stats.median_ns) /
+            it->stats.median_ns;
+        bool regressed = change > threshold;
+        failures += regressed;
+        std::printf("%-22s %-10s %9zu %14.1f %14.1f %+8.1f%%%s\n",
+                    r.kernel.c_str(), r.distribution.c_str(), r.size,
+                    it->stats.median_ns / 1000.0, r.stats.median_ns / 1000.0,
+                    change, regressed ? "  REGRESSION" : "");
+    }
+    for (const Result &b : baseline) {
+        bool measured =
+            std::any_of(results.begin(), results.end(),
+                        [&b](const Result &r) { return sameCase(b, r); });
+        if (measured)
+            continue;
+        ++failures;
+        std::printf("%-22s %-10s %9zu %14.1f %14s %9s  MISSING\n",
+                    b.kernel.c_str(), b.distribution.c_str(), b.size,
+                    b.stats.median_ns / 1000.0, "-", "-");
+    }
+    return failures;
+}
+
+// std::sto* stop at the first bad character ("1k" parses as 1), so insist
+// on the whole argument being consumed.
+void requireWhole(const std::string &text, std::size_t used) {
+    if (used != text.size())
+        throw std::invalid_argument(text);
+}
+
+int parseInt(const std::string &text) {
+    std::size_t used = 0;
+    int value = std::stoi(text, &used);
+    requireWhole(text, used);
+    return value;
+}
+
+double parseDouble(const std::string &text) {
+    std::size_t used = 0;
+    double value = std::stod(text, &used);
+    requireWhole(text, used);
+    return value;
+}
+
+std::vector<std::size_t> parseSizes(const std::string &list) {
+    std::vector<std::size_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty())
+            continue;
+        // stoul silently wraps negative numbers
+        if (item.find('-') != std::string::npos)
+            throw std::invalid_argument(item);
+        std::size_t used = 0;
+        sizes.push_back(std::stoul(item, &used));
+        requireWhole(item, used);
+    }
+    return sizes;
+}
+
+/**
+ * @brief Parse command line arguments into options.
+ * @return false on unknown flags, missing values or malformed numbers.
+ */
+bool parseOptions(int argc, char *argv[], Options &options) try {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--sizes" && has_value)
+            options.sizes = parseSizes(argv[++i]);
+        else if (arg == "--reps" && has_value)
+            options.reps = std::max(1, parseInt(argv[++i]));
+        else if (arg == "--warmup" && has_value)
+            options.warmup = std::max(0, parseInt(argv[++i]));
+        else if (arg == "--threshold" && has_value)
+            options.threshold = parseDouble(argv[++i]);
+        else if (arg == "--out" && has_value)
+            options.out = argv[++i];
+        else if (arg == "--baseline" && has_value)
+            options.baseline = argv[++i];
+        else if (arg == "--render")
+            options.render = true;
+        else
+            return false;
+    }
+    return true;
+} catch (const std::exception &) {
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--sizes 1000,10000,100000] [--reps N] [--warmup N]"
+                     " [--render] [--out results.json] [--baseline baseline.json]"
+                     " [--threshold percent]\n";
+        return 2;
+    }
+
+    // Rendering needs a GL context. On X11 SFML aborts instead of failing
+    // when there is no display, so check before creating the texture.
+    std::unique_ptr<sf::RenderTexture> texture;
+    std::unique_ptr<Renderer> renderer;
+    if (options.render) {
+#if defined(__unix__) && !defined(__APPLE__)
+        if (!std::getenv("DISPLAY")) {
+            std::cerr << "--render needs a display, DISPLAY is not set\n";
+            return 2;
+        }
+#endif
+        texture = std::make_unique<sf::RenderTexture>();
+        if (!texture->create(static_cast<unsigned>(world_size),
+                             static_cast<unsigned>(world_size))) {
+            std::cerr << "Failed to create render texture\n";
+            return 2;
+        }
+        renderer = std::make_unique<Renderer>(*texture);
+    }
+    const Camera camera{{world_size, world_size}};
+
+    const std::vector<std::pair<std::string, Kernel>> kernels = {
+            {"Particle::update", KernelBench::particleUpdate},
+            {"checkCollisions", KernelBench::checkCollisions},
+            {"getCollisionParticles",
+             [](ParticleManager &m) {
+                 sink = KernelBench::getCollisionParticles(m);
+             }},
+            {"applyBoundary", KernelBench::applyBoundary},
+        };
+
+    std::vector<Result> results;
+    std::printf("%-22s %-10s %9s %12s %12s %12s %12s\n", "kernel", "dist",
+                "size", "min(us)", "median(us)", "p99(us)", "max(us)");
+
+    for (Distribution distribution :
+         {Distribution::Uniform, Distribution::Clustered,
+          Distribution::Packed}) {
+        for (std::size_t size : options.sizes) {
+            auto scene = std::make_unique<ParticleManager>();
+            KernelBench::populate(*scene, makePositions(distribution, size));
+
+            const int reps = repsFor(options, size);
+
+            auto record = [&](const std::string &name, const Stats &stats) {
+                results.push_back(
+                    {name, distributionName(distribution), size, stats});
+                std::string p99 = "-";
+                if (stats.p99_ns > 0.0) {
+                    char buffer[32];
+                    std::snprintf(buffer, sizeof(buffer), "%.1f",
+                                  stats.p99_ns / 1000.0);
+                    p99 = buffer;
+                }
+                std::printf("%-22s %-10s %9zu %12.1f %12.1f %12s %12.1f\n",
+                            name.c_str(), distributionName(distribution), size,
+                            stats.min_ns / 1000.0, stats.median_ns / 1000.0,
+                            p99.c_str(), stats.max_ns / 1000.0);
+                std::fflush(stdout);
+            };
+
+            for (const auto &[name, kernel] : kernels)
+                record(name, measure(*scene, options.warmup, reps, kernel));
+
+            // Times the CPU-side vertex build and draw submission only.
+            // Flushing the previous frame and clearing happen in setup.
+            if (renderer)
+                record("Renderer::render",
+                       measure(
+                           *scene, options.warmup, reps,
+                           [&](ParticleManager &m) {
+                               renderer->render(m, camera);
+                           },
+                           [&](ParticleManager &) {
+                               texture->display();
+                               texture->clear();
+                           }));
+        }
+    }
+
+    if (!options.out.empty() && !writeJson(options.out, results)) {
+        std::cerr << "Failed to write " << options.out << "\n";
+        return 2;
+    }
+
+    if (!options.baseline.empty()) {
+        std::vector<Result> baseline = readBaseline(options.baseline);
+        if (baseline.empty()) {
+            std::cerr << "No results found in baseline " << options.baseline
+                      << "\n";
+            return 2;
+        }
+        int failures = compare(results, baseline, options.threshold);
+        if (failures > 0) {
+            std::printf("\n%d kernel(s) regressed above %.1f%% or missing\n",
+                        failures, options.threshold);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#ifndef COMMAND_QUEUE_H_
+#define COMMAND_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @file command_queue.hpp
+ * @brief Bounded lock-free multi-producer single-consumer queue.
+ */
+
+/**
+ * @class CommandQueue
+ * @brief Fixed-capacity ring buffer that any number of threads can push into
+ * and a single thread pops from, without locks.
+ *
+ * Each slot carries a sequence number telling producers and the consumer
+ * whether it is free or holds a published value (Vyukov's bounded queue).
+ * Producers only contend on a single compare-and-swap of the tail index;
+ * pushing into a full queue fails instead of blocking.
+ *
+ * @tparam T Element type, must be default constructible and copyable.
+ */
+template <typename T> class CommandQueue {
+  public:
+    /**
+     * @brief Allocate a queue holding at least capacity elements.
+     *
+     * @param capacity Requested capacity, rounded up to a power of two.
+     */
+    explicit CommandQueue(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        mask = size - 1;
+        slots = std::make_unique<Slot[]>(size);
+        for (std::size_t i = 0; i < size; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    /**
+     * @brief Enqueue a value. Safe to call from any number of threads.
+     *
+     * @return true on success, false if the queue is full.
+     */
+    bool tryPush(const T &value) noexcept {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;) {
+            slot = &slots[pos & mask];
+            std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            std::intptr_t diff =
+                static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false; // Slot still holds an unconsumed value
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Dequeue the oldest published value. Single consumer only.
+     *
+     * @return true if a value was written to value, false if the queue is
+     * empty.
+     */
+    bool tryPop(T &value) noexcept {
+        Slot &slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+            return false;
+        value = slot.value;
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    std::size_t capacity() const noexcept { return mask + 1; }
+
+  private:
+    struct Slot {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask = 0;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<std::size_t> tail{0};
+    alignas(64) std::size_t head = 0;
+};
+
+#endif // COMMAND_QUEUE_H_
@@ -23,6 +23,9 @@ int main(int argc, char *argv[]) {
     const uint32_t frame_rate = 60;
     window.setFramerateLimit(frame_rate);
     Renderer renderer{window};
+    Camera camera{{static_cast<float>(window_width),
+                   static_cast<float>(window_height)}};
+    const float pan_speed = 10.0f; // Screen pixels per frame
 
     ParticleManager manager;
 
@@ -46,49 +49,60 @@ int main(int argc, char *argv[]) {
                     sf::Keyboard::Escape)) { // Terminate program
                 window.close();
             }
+            // Zoom camera on mouse wheel
+            if (event.type == sf::Event::MouseWheelScrolled)
+                camera.zoom(event.mouseWheelScroll.delta > 0 ? 0.9f : 1.1f);
         }
 
+        // Pan camera on key press, speed is constant on screen
+        const float pan_step =
+            pan_speed * camera.getView().getSize().x / window_width;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
+            camera.pan({0.0f, -pan_step});
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
+            camera.pan({0.0f, pan_step});
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
+            camera.pan({-pan_step, 0.0f});
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
+            camera.pan({pan_step, 0.0f});
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::R))
+            camera.reset();
+
         // Move gravity on key press
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up))
-            manager.toggleGravityUp();
+            manager.pushCommand(GravityCommand{{0.0f, -1000.0f}});
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down))
-            manager.toggleGravityDown();
+            manager.pushCommand(GravityCommand{{0.0f, 1000.0f}});
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
-            manager.toggleGravityLeft();
+            manager.pushCommand(GravityCommand{{-1000.0f, 0.0f}});
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
-            manager.toggleGravityRight();
+            manager.pushCommand(GravityCommand{{1000.0f, 0.0f}});
 
         // Spaen Particles
         if (manager.getObjects().size() < max_objects &&
             spawn_clock.getElapsedTime().asSeconds() >= spawn_delay) {
             float t = timer.getElapsedTime().asSeconds();
-            auto &object = manager.addObject(spawn_position, radius);
-
             float angle = M_PI * 0.5f + max_angle * std::sin(3 * t);
-            object.color = getColor(t);
 
-            manager.setObjectVelocity(
-                object, spawn_velocity *
-                            sf::Vector2f(std::cos(angle), std::sin(angle)));
+            manager.pushCommand(SpawnCommand{
+                spawn_position,
+                spawn_velocity * sf::Vector2f(std::cos(angle), std::sin(angle)),
+                radius, getColor(t)});
             spawn_clock.restart();
         }
 
         // Mouuse pull
         if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-            float ratio = 840.0f / window.getSize().x;
-            sf::Vector2f pos =
-                static_cast<sf::Vector2f>(sf::Mouse::getPosition(window)) *
-                ratio;
-            manager.mousePull(pos);
+            sf::Vector2f pos = window.mapPixelToCoords(
+                sf::Mouse::getPosition(window), camera.getView());
+            manager.pushCommand(PullCommand{pos});
         }
 
         // Mouse Push
         if (sf::Mouse::isButtonPressed(sf::Mouse::Right)) {
-            float ratio = 840.0f / window.getSize().x;
-            sf::Vector2f pos =
-                static_cast<sf::Vector2f>(sf::Mouse::getPosition(window)) *
-                ratio;
-            manager.mousePush(pos);
+            sf::Vector2f pos = window.mapPixelToCoords(
+                sf::Mouse::getPosition(window), camera.getView());
+            manager.pushCommand(PushCommand{pos});
         }
 
         fps_timer.restart();
@@ -98,7 +112,7 @@ int main(int argc, char *argv[]) {
         float ms = 1.0 * fps_timer.getElapsedTime().asMicroseconds() / 100;
 
         window.clear(sf::Color::White);
-        renderer.render(manager);
+        renderer.render(manager, camera);
 
         ms = 1.0 * fps_timer.getElapsedTime().asMicroseconds() / 1000;
 
@@ -1,6 +1,8 @@
 #include "particle.hpp"
 #include "SFML/System/Vector2.hpp"
+#include <algorithm>
 #include <cmath>
+#include <type_traits>
 
 void Particle::update(const float dt) noexcept {
     sf::Vector2f displacement = position - position_last;
@@ -8,8 +10,8 @@ void Particle::update(const float dt) noexcept {
     position = position + displacement + acceleration * (dt * dt);
     acceleration = {};
 
-    gridx = position.x / 15;
-    gridy = position.y / 15;
+    gridx = position.x / grid_cell_size;
+    gridy = position.y / grid_cell_size;
 }
 
 void Particle::setVelocity(const sf::Vector2f &v, const float dt) noexcept {
@@ -28,14 +30,91 @@ void Particle::accelerate(const sf::Vector2f &a) noexcept { acceleration += a; }
 
 Particle &ParticleManager::addObject(const sf::Vector2f &position,
                                      const float radius) noexcept {
-    int gridx = position.x / grid_size, gridy = position.x / grid_size;
+    const float max_cell = grid_cells - 1;
+    int gridx = std::clamp(position.x / grid_cell_size, 0.0f, max_cell);
+    int gridy = std::clamp(position.y / grid_cell_size, 0.0f, max_cell);
     Particle newParticle =
         Particle(position, radius, gridx, gridy, objects.size());
     grid[gridx][gridy].push_back(objects.size());
     return objects.emplace_back(newParticle);
 }
 
+namespace {
+bool isFinite(const sf::Vector2f &v) noexcept {
+    return std::isfinite(v.x) && std::isfinite(v.y);
+}
+} // namespace
+
+bool ParticleManager::pushCommand(const Command &command) noexcept {
+    return commands.tryPush(command);
+}
+
+void ParticleManager::applyCommands() noexcept {
+    Command command;
+    for (std::size_t i = 0; i < commands.capacity() && commands.tryPop(command);
+         ++i) {
+        std::visit(
+            [this](auto &&cmd) {
+                using T = std::decay_t<decltype(cmd)>;
+                if constexpr (std::is_same_v<T, SpawnCommand>) {
+                    applySpawn(cmd);
+                } else if constexpr (std::is_same_v<T, PullCommand>) {
+                    if (isFinite(cmd.position))
+                        mousePull(cmd.position);
+                } else if constexpr (std::is_same_v<T, PushCommand>) {
+                    if (isFinite(cmd.position))
+                        mousePush(cmd.position);
+                } else if constexpr (std::is_same_v<T, GravityCommand>) {
+                    if (isFinite(cmd.gravity))
+                        gravity = cmd.gravity;
+                } else if constexpr (std::is_same_v<T, ParametersCommand>) {
+                    if (cmd.step_dt > 0.0f)
+                        step_dt =
+                            std::clamp(cmd.step_dt, min_step_dt, max_step_dt);
+                    if (cmd.sub_steps > 0)
+                        sub_steps = std::min(cmd.sub_steps, max_sub_steps);
+                }
+            },
+            command);
+    }
+}
+
+void ParticleManager::applySpawn(const SpawnCommand &command) noexcept {
+    // Commands come from outside code, reject anything that would place a
+    // particle outside the world or poison the simulation with NaNs. Radii
+    // above half a grid cell would be missed by the collision search.
+    const float radius = command.radius;
+    if (!std::isfinite(radius) || radius <= 0.0f ||
+        2.0f * radius > grid_cell_size || !isFinite(command.position) ||
+        !isFinite(command.velocity) || !isFinite(command.offset) ||
+        !std::isfinite(command.angle_step))
+        return;
+
+    // A batch without offset would stack every particle on one spot
+    if (command.count > 1 && command.offset == sf::Vector2f{})
+        return;
+
+    const int count = std::clamp(command.count, 0, max_spawn_batch);
+    for (int i = 0; i < count; ++i) {
+        // Skip rather than clamp, clamping would stack the rest of a batch
+        // on the same spot
+        const sf::Vector2f pos = command.position + command.offset * float(i);
+        if (pos.x < radius || pos.x > window_size - radius ||
+            pos.y < radius || pos.y > window_size - radius)
+            continue;
+
+        const float angle = command.angle_step * i;
+        const float c = std::cos(angle), s = std::sin(angle);
+        const sf::Vector2f &v = command.velocity;
+
+        Particle &object = addObject(pos, radius);
+        object.color = command.color;
+        setObjectVelocity(object, {v.x * c - v.y * s, v.x * s + v.y * c});
+    }
+}
+
 void ParticleManager::update() {
+    applyCommands();
     float substep_dt = step_dt / sub_steps;
     for (int i = 0; i < sub_steps; ++i) {
         applyGravity();
@@ -54,13 +133,13 @@ float ParticleManager::getStepDt() const noexcept {
     return step_dt / sub_steps;
 }
 
-void inline ParticleManager::applyGravity() noexcept {
+void ParticleManager::applyGravity() noexcept {
     for (auto &obj : objects) {
         obj.accelerate((gravity));
     }
 }
 
-void inline ParticleManager::applyBoundary() noexcept {
+void ParticleManager::applyBoundary() noexcept {
     for (auto &obj : objects) {
         const float dampening = 0.75f;
         const sf::Vector2f pos = obj.position;
@@ -93,7 +172,7 @@ void inline ParticleManager::applyBoundary() noexcept {
     }
 }
 
-void inline ParticleManager::checkCollisions() noexcept {
+void ParticleManager::checkCollisions() noexcept {
     int num_objects = objects.size();
     for (Particle &obj_1 : objects) {
         for (int i : getCollisionParticles(obj_1.id)) {
@@ -103,7 +182,13 @@ void inline ParticleManager::checkCollisions() noexcept {
             float min_dist = obj_1.radius + obj_2.radius;
 
             if (dist < min_dist) {
-                sf::Vector2f n = v / dist; // Normalize
+                // Coincident particles have no separation direction, push
+                // them apart along x in id order so they cannot stay stacked
+                sf::Vector2f n = dist > 0.0f
+                                     ? v / dist // Normalize
+                                     : sf::Vector2f{
+                                           obj_1.id < obj_2.id ? 1.0f : -1.0f,
+                                           0.0f};
                 float delta = 0.5f * (min_dist - dist);
 
                 obj_1.position += n * 0.5f * delta;
@@ -119,7 +204,7 @@ ParticleManager::getCollisionParticles(int particleID) const noexcept {
     std::vector<int> res;
     for (int i = p.gridx - 1; i <= p.gridx + 1; ++i) {
         for (int j = p.gridy - 1; j <= p.gridy + 1; ++j) {
-            if (i < 0 || j < 0 || i >= 56 || j >= 56)
+            if (i < 0 || j < 0 || i >= grid_cells || j >= grid_cells)
                 continue;
             for (int new_id : grid[i][j])
                 if (new_id != p.id)
@@ -129,12 +214,16 @@ ParticleManager::getCollisionParticles(int particleID) const noexcept {
     return res;
 }
 
-void inline ParticleManager::updateObjects(const float dt) noexcept {
-    for (int i = 0; i < 100; ++i)
-        for (int j = 0; j < 100; ++j)
+void ParticleManager::updateObjects(const float dt) noexcept {
+    for (int i = 0; i < grid_cells; ++i)
+        for (int j = 0; j < grid_cells; ++j)
             grid[i][j].clear();
     for (auto &obj : objects) {
         obj.update(dt);
+        // Crowded particles can be pushed past the border for a step, keep
+        // them in the nearest edge cell
+        obj.gridx = std::clamp(obj.gridx, 0, grid_cells - 1);
+        obj.gridy = std::clamp(obj.gridy, 0, grid_cells - 1);
         grid[obj.gridx][obj.gridy].push_back(obj.id);
     }
 }
@@ -143,6 +232,16 @@ std::vector<Particle> &ParticleManager::getObjects() noexcept {
     return objects;
 }
 
+float ParticleManager::getGridSize() const noexcept { return grid_cell_size; }
+
+const std::vector<int> &ParticleManager::getGridCell(int x,
+                                                      int y) const noexcept {
+    static const std::vector<int> empty;
+    if (x < 0 || y < 0 || x >= grid_cells || y >= grid_cells)
+        return empty;
+    return grid[x][y];
+}
+
 void ParticleManager::mousePull(const sf::Vector2f &pos) {
     for (auto &obj : objects) {
         sf::Vector2 dir = pos - obj.position;
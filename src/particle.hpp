@@ -1,7 +1,9 @@
 #ifndef PARTICAL_H_
 #define PARTICAL_H_
 
+#include "command_queue.hpp"
 #include <SFML/Graphics.hpp>
+#include <variant>
 #include <vector>
 
 /**
@@ -14,6 +16,19 @@
  * (e.g., gravity), simple boundary constraints, and basic collision handling.
  */
 
+/**
+ * @brief Side length of the square simulation world in pixels.
+ */
+constexpr float world_size = 840.0f;
+
+/**
+ * @brief Edge length of one collision grid cell in pixels.
+ *
+ * Collision search only looks at neighbouring cells, so particle radii must
+ * not exceed half a cell.
+ */
+constexpr float grid_cell_size = 15.0f;
+
 /**
  * @class Particle
  * @brief Represents a single particle with position, radius, color, and
@@ -144,6 +159,67 @@ class Particle {
     sf::Vector2f getVelocity() noexcept;
 };
 
+/**
+ * @brief Spawn a batch of count particles with an initial velocity.
+ *
+ * Particle i of the batch is placed at position + i * offset and its velocity
+ * is rotated by i * angle_step radians, so a single command can lay out a
+ * line or fan of particles. Particles that would start outside the world are
+ * skipped. Commands are dropped if the radius is non-positive, non-finite or
+ * larger than half a grid cell, if any vector is non-finite, or if count > 1
+ * with a zero offset. count is capped at ParticleManager::max_spawn_batch.
+ */
+struct SpawnCommand {
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    float radius = 10.0f;
+    sf::Color color = sf::Color::Cyan;
+    int count = 1;
+    sf::Vector2f offset;
+    float angle_step = 0.0f;
+};
+
+/**
+ * @brief Attract particles toward position, as ParticleManager::mousePull().
+ */
+struct PullCommand {
+    sf::Vector2f position;
+};
+
+/**
+ * @brief Repel particles from position, as ParticleManager::mousePush().
+ */
+struct PushCommand {
+    sf::Vector2f position;
+};
+
+/**
+ * @brief Replace the global gravity vector (pixels/s^2).
+ */
+struct GravityCommand {
+    sf::Vector2f gravity;
+};
+
+/**
+ * @brief Change the simulation step parameters.
+ *
+ * Non-positive values leave the corresponding parameter unchanged. Others
+ * are clamped to [ParticleManager::min_step_dt, max_step_dt] and
+ * [1, ParticleManager::max_sub_steps] so one command cannot stall the loop.
+ */
+struct ParametersCommand {
+    float step_dt = 0.0f;
+    int sub_steps = 0;
+};
+
+/**
+ * @brief Any command accepted by ParticleManager::pushCommand().
+ *
+ * Commands carrying non-finite vectors are dropped when applied.
+ */
+using Command = std::variant<SpawnCommand, PullCommand, PushCommand,
+                             GravityCommand, ParametersCommand>;
+
 /**
  * @class ParticleManager
  * @brief Manages a collection of particles, global forces, boundaries, and
@@ -171,6 +247,20 @@ class ParticleManager {
      */
     ParticleManager() = default;
 
+    /**
+     * @brief Queue a command to be applied at the start of the next update().
+     *
+     * Lock-free and safe to call from any thread, so external drivers
+     * (scripts, network listeners, replay feeders) can feed the simulation
+     * without synchronizing with the render loop. Commands are applied in
+     * the order they were queued.
+     *
+     * @param command Command to queue.
+     * @return true if queued, false if the queue is full and the command was
+     * dropped.
+     */
+    bool pushCommand(const Command &command) noexcept;
+
     /**
      * @brief Apply an attractive mouse force toward the given position.
      *
@@ -194,7 +284,8 @@ class ParticleManager {
     /**
      * @brief Create and add a new particle to the system.
      *
-     * @param position Initial position in pixels.
+     * @param position Initial position in pixels. Positions outside the
+     *                 collision grid are filed under the nearest edge cell.
      * @param radius   Particle radius in pixels.
      * @return Particle& Reference to the newly created particle.
      *
@@ -214,8 +305,9 @@ class ParticleManager {
     /**
      * @brief Advance the simulation by one frame.
      *
-     * Splits the nominal step (step_dt) into a number of sub-steps (sub_steps)
-     * for improved stability, applying gravity, boundary constraints, collision
+     * First applies all commands queued through pushCommand(), then splits
+     * the nominal step (step_dt) into a number of sub-steps (sub_steps) for
+     * improved stability, applying gravity, boundary constraints, collision
      * checks, and particle updates each sub-step.
      */
     void update();
@@ -291,7 +383,63 @@ class ParticleManager {
      */
     void toggleGravityRight() noexcept;
 
+    /**
+     * @brief Number of collision grid cells along each axis, enough to cover
+     * the world.
+     */
+    static constexpr int grid_cells =
+        static_cast<int>((world_size + grid_cell_size - 1) / grid_cell_size);
+
+    /**
+     * @brief Largest number of particles one SpawnCommand may add.
+     */
+    static constexpr int max_spawn_batch = 4096;
+
+    /**
+     * @brief Limits applied to ParametersCommand values.
+     */
+    static constexpr int max_sub_steps = 64;
+    static constexpr float min_step_dt = 1.0f / 1000;
+    static constexpr float max_step_dt = 1.0f / 10;
+
+    /**
+     * @brief Get the edge length of one collision grid cell.
+     *
+     * @return float Cell size in pixels.
+     */
+    float getGridSize() const noexcept;
+
+    /**
+     * @brief Access the particle ids stored in one collision grid cell.
+     *
+     * The grid is rebuilt at the end of every update(), so between updates it
+     * matches the current particle positions. Used by the renderer to visit
+     * only the cells that intersect the camera view.
+     *
+     * @param x Cell column.
+     * @param y Cell row.
+     * @return const std::vector<int>& Ids of the particles in the cell, empty
+     * if (x, y) lies outside the grid.
+     */
+    const std::vector<int> &getGridCell(int x, int y) const noexcept;
+
   private:
+    /**
+     * @brief Microbenchmark harness (bench/kernels.cpp), times the private
+     * simulation kernels in isolation.
+     */
+    friend class KernelBench;
+
+    /**
+     * @brief Maximum number of commands pending between two updates.
+     */
+    static constexpr std::size_t command_capacity = 1 << 14;
+
+    /**
+     * @brief Commands pushed by producer threads, drained by update().
+     */
+    CommandQueue<Command> commands{command_capacity};
+
     /**
      * @brief Container of all managed particles.
      */
@@ -308,7 +456,7 @@ class ParticleManager {
      * @brief Nominal window size in pixels (used for clamping or scaling
      * behavior).
      */
-    float window_size = 840.0f;
+    float window_size = world_size;
 
     /**
      * @brief Radius of the circular boundary in pixels.
@@ -331,23 +479,30 @@ class ParticleManager {
     float sub_steps = 8;
 
     /**
-     * @brief Size of each grid in the collision detection system
+     * @brief Vector holding the grid for collision detection
      *
      * */
-    float grid_size = 12;
+    std::vector<int> grid[grid_cells][grid_cells];
 
     /**
-     * @brief Vector holding the grid for collision detection
+     * @brief Apply the commands queued so far.
      *
-     * */
-    std::vector<int> grid[100][100];
+     * At most one queue's worth is drained per call, so producers that keep
+     * pushing cannot stall the simulation loop.
+     */
+    void applyCommands() noexcept;
+
+    /**
+     * @brief Validate and apply one spawn command.
+     */
+    void applySpawn(const SpawnCommand &command) noexcept;
 
     /**
      * @brief Apply global gravity to all particles.
      *
      * Adds the gravity vector to each particle's acceleration.
      */
-    void inline applyGravity() noexcept;
+    void applyGravity() noexcept;
 
     /**
      * @brief Constrain particles to remain within the circular boundary.
@@ -355,7 +510,7 @@ class ParticleManager {
      * Implementation may clamp positions and/or adjust velocities to keep
      * particles inside the defined circle.
      */
-    void inline applyBoundary() noexcept;
+    void applyBoundary() noexcept;
 
     /**
      * @brief Resolve inter-particle collisions.
@@ -363,10 +518,9 @@ class ParticleManager {
      * Typically uses simple circle overlap resolution based on particle radii.
      * Behavior is implementation-specific (e.g., positional correction only).
      */
-    void inline checkCollisions() noexcept;
+    void checkCollisions() noexcept;
 
-    std::vector<int> inline getCollisionParticles(
-        int particleID) const noexcept;
+    std::vector<int> getCollisionParticles(int particleID) const noexcept;
 
     /**
      * @brief Update all particles by a sub-step dt.
@@ -376,7 +530,7 @@ class ParticleManager {
      *
      * @param dt Sub-step time delta in seconds.
      */
-    void inline updateObjects(const float dt) noexcept;
+    void updateObjects(const float dt) noexcept;
 };
 
 #endif // PARTICAL_H_
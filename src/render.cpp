@@ -1,16 +1,139 @@
 #include "render.hpp"
-#include "SFML/Graphics/CircleShape.hpp"
-#include <string>
+#include <algorithm>
+#include <cmath>
 
-void Renderer::render(ParticleManager &manager) {
-    // Draw Particles
-    sf::CircleShape circle{1.0f};
-    circle.setPointCount(32);
+namespace {
+// On-screen radius (pixels) below which a particle is drawn as a point
+const float point_radius = 1.0f;
+// On-screen radius (pixels) below which a particle is drawn as a quad
+const float quad_radius = 2.5f;
+// Maximum allowed distance (pixels) between a true circle and its polygon
+const float max_circle_error = 0.25f;
+const int min_segments = 8;
+const int max_segments = 32;
+// Zoom limits relative to the whole world
+const float min_zoom = 1.0f / 32;
+const float max_zoom = 4.0f;
+} // namespace
+
+Camera::Camera(const sf::Vector2f &world_size_)
+    : world_size{world_size_}, view{world_size_ * 0.5f, world_size_} {}
+
+void Camera::zoom(const float factor) noexcept {
+    float new_zoom = std::clamp(zoom_level * factor, min_zoom, max_zoom);
+    view.zoom(new_zoom / zoom_level);
+    zoom_level = new_zoom;
+}
+
+void Camera::pan(const sf::Vector2f &offset) noexcept { view.move(offset); }
+
+void Camera::reset() noexcept {
+    view = sf::View{world_size * 0.5f, world_size};
+    zoom_level = 1.0f;
+}
+
+const sf::View &Camera::getView() const noexcept { return view; }
+
+sf::FloatRect Camera::getBounds() const noexcept {
+    const sf::Vector2f size = view.getSize();
+    return {view.getCenter() - size * 0.5f, size};
+}
+
+Renderer::Renderer(sf::RenderTarget &target_) : target{target_} {
+    unit_circles.resize(max_segments + 1);
+    for (int n = min_segments; n <= max_segments; ++n) {
+        for (int i = 0; i < n; ++i) {
+            float angle = 2.0f * M_PI * i / n;
+            unit_circles[n].emplace_back(std::cos(angle), std::sin(angle));
+        }
+    }
+}
+
+void Renderer::render(ParticleManager &manager, const Camera &camera) {
+    const sf::View previous_view = target.getView();
+    target.setView(camera.getView());
+
+    const sf::FloatRect bounds = camera.getBounds();
+
+    // World to screen scale along each axis, the view may be stretched after
+    // a non-square resize. The smaller one bounds the on-screen radius.
+    const sf::View &view = camera.getView();
+    const sf::FloatRect viewport = view.getViewport();
+    const float pixels_per_unit =
+        std::min(target.getSize().x * viewport.width / view.getSize().x,
+                 target.getSize().y * viewport.height / view.getSize().y);
+
+    // Visit only the grid cells under the view, plus one cell on each side
+    // for particles that overlap the view from a neighbouring cell
+    const float cell = manager.getGridSize();
+    const int last = ParticleManager::grid_cells - 1;
+    const int min_x = std::max(0, int(std::floor(bounds.left / cell)) - 1);
+    const int min_y = std::max(0, int(std::floor(bounds.top / cell)) - 1);
+    const int max_x = std::min(
+        last, int(std::floor((bounds.left + bounds.width) / cell)) + 1);
+    const int max_y = std::min(
+        last, int(std::floor((bounds.top + bounds.height) / cell)) + 1);
+
+    triangles.clear();
+    points.clear();
     const auto &objects = manager.getObjects();
-    for (const auto &obj : objects) {
-        circle.setPosition(obj.position);
-        circle.setScale(obj.radius, obj.radius);
-        circle.setFillColor(obj.color);
-        target.draw(circle);
+    for (int x = min_x; x <= max_x; ++x) {
+        for (int y = min_y; y <= max_y; ++y) {
+            for (int id : manager.getGridCell(x, y)) {
+                const Particle &obj = objects[id];
+                if (obj.position.x + obj.radius < bounds.left ||
+                    obj.position.x - obj.radius > bounds.left + bounds.width ||
+                    obj.position.y + obj.radius < bounds.top ||
+                    obj.position.y - obj.radius > bounds.top + bounds.height)
+                    continue;
+
+                // Level of detail from on-screen size
+                const float screen_radius = obj.radius * pixels_per_unit;
+                if (screen_radius < point_radius) {
+                    points.append(sf::Vertex(obj.position, obj.color));
+                } else if (screen_radius < quad_radius) {
+                    appendQuad(obj);
+                } else {
+                    // Fewest segments keeping the outline within
+                    // max_circle_error pixels of the true circle
+                    int segments = static_cast<int>(std::ceil(
+                        M_PI /
+                        std::acos(1.0f - max_circle_error / screen_radius)));
+                    appendCircle(obj, std::clamp(segments, min_segments,
+                                                 max_segments));
+                }
+            }
+        }
+    }
+
+    target.draw(triangles);
+    target.draw(points);
+    target.setView(previous_view);
+}
+
+void Renderer::appendQuad(const Particle &obj) {
+    const sf::Vector2f &p = obj.position;
+    const float r = obj.radius;
+    const sf::Vertex top_left({p.x - r, p.y - r}, obj.color);
+    const sf::Vertex top_right({p.x + r, p.y - r}, obj.color);
+    const sf::Vertex bottom_right({p.x + r, p.y + r}, obj.color);
+    const sf::Vertex bottom_left({p.x - r, p.y + r}, obj.color);
+    triangles.append(top_left);
+    triangles.append(top_right);
+    triangles.append(bottom_right);
+    triangles.append(top_left);
+    triangles.append(bottom_right);
+    triangles.append(bottom_left);
+}
+
+void Renderer::appendCircle(const Particle &obj, const int segments) {
+    const std::vector<sf::Vector2f> &outline = unit_circles[segments];
+    const sf::Vertex center(obj.position, obj.color);
+    for (int i = 0; i < segments; ++i) {
+        const sf::Vector2f &a = outline[i];
+        const sf::Vector2f &b = outline[(i + 1) % segments];
+        triangles.append(center);
+        triangles.append(sf::Vertex(obj.position + a * obj.radius, obj.color));
+        triangles.append(sf::Vertex(obj.position + b * obj.radius, obj.color));
     }
 }
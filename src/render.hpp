@@ -3,15 +3,82 @@
 
 #include "particle.hpp"
 #include <SFML/Graphics.hpp>
+#include <vector>
+
+/**
+ * @class Camera
+ * @brief Zoomable, pannable view onto the simulation world.
+ *
+ * Thin wrapper around an sf::View that starts out showing the whole world and
+ * keeps the zoom level within sensible limits.
+ */
+class Camera {
+  public:
+    /**
+     * @brief Create a camera showing the whole world.
+     *
+     * @param world_size_ World extent in pixels, starting at (0, 0).
+     */
+    explicit Camera(const sf::Vector2f &world_size_);
+
+    /**
+     * @brief Scale the visible area by factor, about the view center.
+     *
+     * Follows sf::View::zoom semantics: factor > 1 zooms out, factor < 1
+     * zooms in.
+     */
+    void zoom(const float factor) noexcept;
+
+    /**
+     * @brief Move the view center by offset world pixels.
+     */
+    void pan(const sf::Vector2f &offset) noexcept;
+
+    /**
+     * @brief Show the whole world again.
+     */
+    void reset() noexcept;
+
+    const sf::View &getView() const noexcept;
+
+    /**
+     * @brief Visible area in world coordinates.
+     */
+    sf::FloatRect getBounds() const noexcept;
+
+  private:
+    sf::Vector2f world_size;
+    sf::View view;
+    float zoom_level = 1.0f;
+};
 
 class Renderer {
   public:
-    Renderer(sf::RenderTarget &target_) : target{target_} {}
+    Renderer(sf::RenderTarget &target_);
 
-    void render(ParticleManager &manager);
+    /**
+     * @brief Draw the particles visible through camera.
+     *
+     * Only grid cells intersecting the camera bounds are visited. Particles
+     * are batched into two vertex arrays and drawn with a level of detail
+     * picked from their on-screen radius: a single point when sub-pixel, a
+     * quad when tiny, otherwise a circle with just enough segments.
+     */
+    void render(ParticleManager &manager, const Camera &camera);
 
   private:
     sf::RenderTarget &target;
+
+    sf::VertexArray triangles{sf::Triangles};
+    sf::VertexArray points{sf::Points};
+
+    /**
+     * @brief Unit circle outlines, indexed by segment count.
+     */
+    std::vector<std::vector<sf::Vector2f>> unit_circles;
+
+    void appendQuad(const Particle &obj);
+    void appendCircle(const Particle &obj, const int segments);
 };
 
 #endif // RENDER_H_